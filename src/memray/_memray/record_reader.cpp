@@ -185,6 +185,22 @@ RecordReader::processFramePush(const FramePush& record)
     return true;
 }
 
+bool
+RecordReader::processFramePushBatch()
+{
+    size_t count;
+    if (!readVarint(&count)) {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        FramePush record;
+        if (!parseFramePush(&record) || !processFramePush(record)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool
 RecordReader::parseFramePop(FramePop* record, unsigned int flags)
 {
@@ -192,6 +208,12 @@ RecordReader::parseFramePop(FramePop* record, unsigned int flags)
     return true;
 }
 
+bool
+RecordReader::parseFramePopWide(FramePop* record)
+{
+    return readVarint(&record->count);
+}
+
 bool
 RecordReader::processFramePop(const FramePop& record)
 {
@@ -573,6 +595,12 @@ RecordReader::nextRecordFromAllAllocationsFile()
                     return RecordResult::ERROR;
                 }
             } break;
+            case RecordType::FRAME_PUSH_BATCH: {
+                if (!processFramePushBatch()) {
+                    if (d_input->is_open()) LOG(ERROR) << "Failed to process frame push batch";
+                    return RecordResult::ERROR;
+                }
+            } break;
             case RecordType::FRAME_POP: {
                 FramePop record;
                 if (!parseFramePop(&record, record_type_and_flags.flags) || !processFramePop(record)) {
@@ -580,6 +608,13 @@ RecordReader::nextRecordFromAllAllocationsFile()
                     return RecordResult::ERROR;
                 }
             } break;
+            case RecordType::FRAME_POP_WIDE: {
+                FramePop record;
+                if (!parseFramePopWide(&record) || !processFramePop(record)) {
+                    if (d_input->is_open()) LOG(ERROR) << "Failed to process wide frame pop";
+                    return RecordResult::ERROR;
+                }
+            } break;
             case RecordType::FRAME_INDEX: {
                 tracking_api::pyframe_map_val_t record;
                 if (!parseFrameIndex(&record, record_type_and_flags.flags) || !processFrameIndex(record))
@@ -1042,6 +1077,24 @@ RecordReader::dumpAllRecordsFromAllAllocationsFile()
 
                 printf("frame_id=%zd\n", record.frame_id);
             } break;
+            case RecordType::FRAME_PUSH_BATCH: {
+                printf("FRAME_PUSH_BATCH ");
+
+                size_t count;
+                if (!readVarint(&count)) {
+                    Py_RETURN_NONE;
+                }
+
+                printf("count=%zd frame_ids=[", count);
+                for (size_t i = 0; i < count; ++i) {
+                    FramePush record;
+                    if (!parseFramePush(&record)) {
+                        Py_RETURN_NONE;
+                    }
+                    printf("%s%zd", i ? " " : "", record.frame_id);
+                }
+                printf("]\n");
+            } break;
             case RecordType::FRAME_POP: {
                 printf("FRAME_POP ");
 
@@ -1052,6 +1105,16 @@ RecordReader::dumpAllRecordsFromAllAllocationsFile()
 
                 printf("count=%zd\n", record.count);
             } break;
+            case RecordType::FRAME_POP_WIDE: {
+                printf("FRAME_POP_WIDE ");
+
+                FramePop record;
+                if (!parseFramePopWide(&record)) {
+                    Py_RETURN_NONE;
+                }
+
+                printf("count=%zd\n", record.count);
+            } break;
             case RecordType::FRAME_INDEX: {
                 printf("FRAME_ID ");
 
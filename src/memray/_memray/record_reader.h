@@ -107,7 +107,10 @@ class RecordReader
     [[nodiscard]] bool parseFramePush(FramePush* record);
     [[nodiscard]] bool processFramePush(const FramePush& record);
 
+    [[nodiscard]] bool processFramePushBatch();
+
     [[nodiscard]] static bool parseFramePop(FramePop* record, unsigned int flags);
+    [[nodiscard]] bool parseFramePopWide(FramePop* record);
     [[nodiscard]] bool processFramePop(const FramePop& record);
 
     [[nodiscard]] bool parseFrameIndex(tracking_api::pyframe_map_val_t* pyframe_val, unsigned int flags);
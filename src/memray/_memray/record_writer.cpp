@@ -64,10 +64,13 @@ class StreamingRecordWriter : public RecordWriter
 
     bool writeThreadSpecificRecord(thread_id_t tid, const FramePop& record) override;
     bool writeThreadSpecificRecord(thread_id_t tid, const FramePush& record) override;
+    bool writeThreadSpecificRecord(thread_id_t tid, const FramePushBatch& record) override;
     bool writeThreadSpecificRecord(thread_id_t tid, const AllocationRecord& record) override;
     bool writeThreadSpecificRecord(thread_id_t tid, const NativeAllocationRecord& record) override;
     bool writeThreadSpecificRecord(thread_id_t tid, const ThreadRecord& record) override;
 
+    bool writeAllocationBatch(const AllocationBatch& batch) override;
+
     bool writeHeader(bool seek_to_start) override;
     bool writeTrailer() override;
 
@@ -105,10 +108,13 @@ class AggregatingRecordWriter : public RecordWriter
 
     bool writeThreadSpecificRecord(thread_id_t tid, const FramePop& record) override;
     bool writeThreadSpecificRecord(thread_id_t tid, const FramePush& record) override;
+    bool writeThreadSpecificRecord(thread_id_t tid, const FramePushBatch& record) override;
     bool writeThreadSpecificRecord(thread_id_t tid, const AllocationRecord& record) override;
     bool writeThreadSpecificRecord(thread_id_t tid, const NativeAllocationRecord& record) override;
     bool writeThreadSpecificRecord(thread_id_t tid, const ThreadRecord& record) override;
 
+    bool writeAllocationBatch(const AllocationBatch& batch) override;
+
     bool writeHeader(bool seek_to_start) override;
     bool writeTrailer() override;
 
@@ -215,33 +221,70 @@ StreamingRecordWriter::writeMappings(const std::vector<ImageSegments>& mappings)
     return writeMappingsCommon(mappings);
 }
 
+namespace {
+
+// Append helpers used to assemble the module map into one contiguous buffer.
+// The encodings must match writeSimpleType/writeString/writeVarint exactly.
+template<typename T>
+void
+appendSimpleType(std::vector<char>& buf, const T& item)
+{
+    static_assert(
+            std::is_trivially_copyable<T>::value,
+            "appendSimpleType called on non trivially copyable type");
+
+    const char* data = reinterpret_cast<const char*>(&item);
+    buf.insert(buf.end(), data, data + sizeof(item));
+}
+
+void
+appendString(std::vector<char>& buf, const char* the_string)
+{
+    buf.insert(buf.end(), the_string, the_string + strlen(the_string) + 1);
+}
+
+void
+appendVarint(std::vector<char>& buf, size_t rest)
+{
+    unsigned char next_7_bits = rest & 0x7f;
+    rest >>= 7;
+    while (rest) {
+        next_7_bits |= 0x80;
+        buf.push_back(next_7_bits);
+        next_7_bits = rest & 0x7f;
+        rest >>= 7;
+    }
+    buf.push_back(next_7_bits);
+}
+
+}  // namespace
+
 bool
 RecordWriter::writeMappingsCommon(const std::vector<ImageSegments>& mappings)
 {
-    RecordTypeAndFlags start_token{RecordType::MEMORY_MAP_START, 0};
-    if (!writeSimpleType(start_token)) {
-        return false;
-    }
+    // Assemble every record into one contiguous buffer and hand it to the
+    // sink in a single call. A process with hundreds of DSOs emits a few
+    // thousand records here on startup and after every dlopen, and each trip
+    // through the sink costs a virtual call and a buffer-space check.
+    std::vector<char> buffer;
+    buffer.reserve(4096);
 
-    for (const auto& image : mappings) {
-        RecordTypeAndFlags segment_header_token{RecordType::SEGMENT_HEADER, 0};
-        if (!writeSimpleType(segment_header_token) || !writeString(image.filename.c_str())
-            || !writeVarint(image.segments.size()) || !writeSimpleType(image.addr))
-        {
-            return false;
-        }
+    appendSimpleType(buffer, RecordTypeAndFlags{RecordType::MEMORY_MAP_START, 0});
 
-        RecordTypeAndFlags segment_token{RecordType::SEGMENT, 0};
+    for (const auto& image : mappings) {
+        appendSimpleType(buffer, RecordTypeAndFlags{RecordType::SEGMENT_HEADER, 0});
+        appendString(buffer, image.filename.c_str());
+        appendVarint(buffer, image.segments.size());
+        appendSimpleType(buffer, image.addr);
 
         for (const auto& segment : image.segments) {
-            if (!writeSimpleType(segment_token) || !writeSimpleType(segment.vaddr)
-                || !writeVarint(segment.memsz)) {
-                return false;
-            }
+            appendSimpleType(buffer, RecordTypeAndFlags{RecordType::SEGMENT, 0});
+            appendSimpleType(buffer, segment.vaddr);
+            appendVarint(buffer, segment.memsz);
         }
     }
 
-    return true;
+    return d_sink->writeAll(buffer.data(), buffer.size());
 }
 
 bool
@@ -265,6 +308,13 @@ StreamingRecordWriter::writeThreadSpecificRecord(thread_id_t tid, const FramePop
     }
 
     size_t count = record.count;
+    if (count > 16) {
+        // Pops too large for one chunked token are emitted as a single
+        // count-prefixed record instead of a run of FRAME_POP tokens.
+        RecordTypeAndFlags token{RecordType::FRAME_POP_WIDE, 0};
+        return writeSimpleType(token) && writeVarint(count);
+    }
+
     while (count) {
         uint8_t to_pop = (count > 16 ? 16 : count);
         count -= to_pop;
@@ -291,6 +341,30 @@ StreamingRecordWriter::writeThreadSpecificRecord(thread_id_t tid, const FramePus
     return writeSimpleType(token) && writeIntegralDelta(&d_last.python_frame_id, record.frame_id);
 }
 
+bool
+StreamingRecordWriter::writeThreadSpecificRecord(thread_id_t tid, const FramePushBatch& record)
+{
+    if (record.count == 1) {
+        // A single push encodes more compactly as a plain FRAME_PUSH record.
+        return StreamingRecordWriter::writeThreadSpecificRecord(tid, FramePush{record.frame_ids[0]});
+    }
+
+    if (!maybeWriteContextSwitchRecordUnsafe(tid)) {
+        return false;
+    }
+
+    RecordTypeAndFlags token{RecordType::FRAME_PUSH_BATCH, 0};
+    if (!writeSimpleType(token) || !writeVarint(record.count)) {
+        return false;
+    }
+    for (size_t i = 0; i < record.count; ++i) {
+        if (!writeIntegralDelta(&d_last.python_frame_id, record.frame_ids[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool
 StreamingRecordWriter::writeThreadSpecificRecord(thread_id_t tid, const AllocationRecord& record)
 {
@@ -332,6 +406,19 @@ StreamingRecordWriter::writeThreadSpecificRecord(thread_id_t tid, const ThreadRe
     return writeSimpleType(token) && writeString(record.name);
 }
 
+bool
+StreamingRecordWriter::writeAllocationBatch(const AllocationBatch& batch)
+{
+    // Note: the explicit qualification lets the compiler devirtualize the
+    // per-record call, so the whole batch costs one virtual dispatch.
+    for (const auto& [tid, record] : batch) {
+        if (!StreamingRecordWriter::writeThreadSpecificRecord(tid, record)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool
 StreamingRecordWriter::writeHeader(bool seek_to_start)
 {
@@ -578,6 +665,17 @@ AggregatingRecordWriter::writeThreadSpecificRecord(thread_id_t tid, const FrameP
     return true;
 }
 
+bool
+AggregatingRecordWriter::writeThreadSpecificRecord(thread_id_t tid, const FramePushBatch& record)
+{
+    for (size_t i = 0; i < record.count; ++i) {
+        if (!AggregatingRecordWriter::writeThreadSpecificRecord(tid, FramePush{record.frame_ids[i]})) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool
 AggregatingRecordWriter::writeThreadSpecificRecord(thread_id_t tid, const AllocationRecord& record)
 {
@@ -623,4 +721,15 @@ AggregatingRecordWriter::writeThreadSpecificRecord(thread_id_t tid, const Thread
     return true;
 }
 
+bool
+AggregatingRecordWriter::writeAllocationBatch(const AllocationBatch& batch)
+{
+    for (const auto& [tid, record] : batch) {
+        if (!AggregatingRecordWriter::writeThreadSpecificRecord(tid, record)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 }  // namespace memray::tracking_api
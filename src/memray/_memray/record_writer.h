@@ -4,6 +4,8 @@
 #include <string>
 #include <type_traits>
 #include <unistd.h>
+#include <utility>
+#include <vector>
 
 #include "sink.h"
 
@@ -12,6 +14,11 @@ namespace memray::tracking_api {
 class RecordWriter
 {
   public:
+    // A batch of allocation records, each tagged with the thread it was
+    // captured on. Batching lets the hot allocation path hand many records to
+    // the writer in a single virtual call instead of one call per record.
+    using AllocationBatch = std::vector<std::pair<thread_id_t, AllocationRecord>>;
+
     virtual ~RecordWriter() = default;
 
     RecordWriter(RecordWriter& other) = delete;
@@ -27,10 +34,13 @@ class RecordWriter
 
     virtual bool writeThreadSpecificRecord(thread_id_t tid, const FramePop& record) = 0;
     virtual bool writeThreadSpecificRecord(thread_id_t tid, const FramePush& record) = 0;
+    virtual bool writeThreadSpecificRecord(thread_id_t tid, const FramePushBatch& record) = 0;
     virtual bool writeThreadSpecificRecord(thread_id_t tid, const AllocationRecord& record) = 0;
     virtual bool writeThreadSpecificRecord(thread_id_t tid, const NativeAllocationRecord& record) = 0;
     virtual bool writeThreadSpecificRecord(thread_id_t tid, const ThreadRecord& record) = 0;
 
+    virtual bool writeAllocationBatch(const AllocationBatch& batch) = 0;
+
     virtual bool writeHeader(bool seek_to_start) = 0;
     virtual bool writeTrailer() = 0;
 
@@ -18,7 +18,7 @@
 namespace memray::tracking_api {
 
 extern const char MAGIC[7];  // Value assigned in records.cpp
-const int CURRENT_HEADER_VERSION = 10;
+const int CURRENT_HEADER_VERSION = 11;
 
 using frame_id_t = size_t;
 using thread_id_t = unsigned long;
@@ -38,6 +38,8 @@ enum class RecordType : unsigned char {
     THREAD_RECORD = 10,
     MEMORY_RECORD = 11,
     CONTEXT_SWITCH = 12,
+    FRAME_PUSH_BATCH = 13,
+    FRAME_POP_WIDE = 14,
 };
 
 enum class OtherRecordType : unsigned char {
@@ -278,6 +280,15 @@ struct FramePush
     frame_id_t frame_id;
 };
 
+// A run of consecutive frame pushes on one thread, emitted as a single
+// record. The pointed-to array must stay alive for the duration of the
+// write call; it is not owned by this struct.
+struct FramePushBatch
+{
+    const frame_id_t* frame_ids;
+    size_t count;
+};
+
 struct FramePop
 {
     size_t count;
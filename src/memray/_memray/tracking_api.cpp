@@ -12,10 +12,19 @@
 #endif
 
 #include <algorithm>
+#include <array>
+#include <fcntl.h>
 #include <mutex>
+#include <sys/resource.h>
 #include <type_traits>
 #include <unistd.h>
 
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#elif defined(__ARM_NEON)
+#    include <arm_neon.h>
+#endif
+
 #include "compat.h"
 #include "exceptions.h"
 #include "hooks.h"
@@ -29,32 +38,150 @@ using namespace std::chrono_literals;
 namespace {
 
 #ifdef __linux__
-std::string
+const std::string&
 get_executable()
 {
-    char buff[PATH_MAX + 1];
-    ssize_t len = ::readlink("/proc/self/exe", buff, sizeof(buff));
-    if (len > PATH_MAX) {
-        throw std::runtime_error("Path to executable is more than PATH_MAX bytes");
-    } else if (len == -1) {
-        throw std::runtime_error("Could not determine executable path");
-    }
-    return std::string(buff, len);
+    // The path cannot change while the process is running, so resolve it once
+    // and reuse it across module cache refreshes.
+    static const std::string executable = [] {
+        char buff[PATH_MAX + 1];
+        ssize_t len = ::readlink("/proc/self/exe", buff, sizeof(buff));
+        if (len > PATH_MAX) {
+            throw std::runtime_error("Path to executable is more than PATH_MAX bytes");
+        } else if (len == -1) {
+            throw std::runtime_error("Could not determine executable path");
+        }
+        return std::string(buff, len);
+    }();
+    return executable;
 }
 
 static bool
-starts_with(const std::string& haystack, const std::string_view& needle)
+starts_with(const char* haystack, const std::string_view& needle)
 {
-    return haystack.compare(0, needle.size(), needle) == 0;
+    // strncmp stops at the first NUL, so this is safe even when the haystack
+    // is shorter than the needle (a fixed-length memcmp would read past it).
+    return ::strncmp(haystack, needle.data(), needle.size()) == 0;
 }
 #endif
 
+// Return the index of the last non-zero byte in [data, data + size), or -1 if
+// every byte is zero. Scanning from the tail in vector-sized chunks lets deep
+// stacks where only the top few entries are non-quiescent be scanned with a
+// handful of vector compares instead of one branch per element.
+ssize_t
+last_nonzero_byte(const uint8_t* data, size_t size)
+{
+#if defined(__AVX2__)
+    while (size >= 32) {
+        size -= 32;
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + size));
+        __m256i is_zero = _mm256_cmpeq_epi8(chunk, _mm256_setzero_si256());
+        uint32_t nonzero_mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(is_zero));
+        if (nonzero_mask) {
+            return size + 31 - __builtin_clz(nonzero_mask);
+        }
+    }
+#elif defined(__ARM_NEON)
+    while (size >= 16) {
+        size -= 16;
+        if (vmaxvq_u8(vld1q_u8(data + size))) {
+            for (size_t i = 16; i != 0; --i) {
+                if (data[size + i - 1]) {
+                    return size + i - 1;
+                }
+            }
+        }
+    }
+#endif
+    while (size--) {
+        if (data[size]) {
+            return size;
+        }
+    }
+    return -1;
+}
+
 }  // namespace
 
 namespace memray::tracking_api {
 
 MEMRAY_FAST_TLS thread_local bool RecursionGuard::isActive = false;
 
+namespace {
+
+// Direct-mapped cache of the UTF-8 function and file names of recently seen
+// code objects. Python workloads call the same few hundred functions over and
+// over, and while PyUnicode_AsUTF8 memoizes its result on the str object, it
+// still walks the unicode internals on every call. A hit here skips both
+// calls entirely. Entries are validated against the code object's current
+// co_name/co_filename pointers, so a code object deallocated and replaced by
+// another one at the same address can't serve stale strings.
+struct CodeObjectStrings
+{
+    PyCodeObject* code;
+    PyObject* name_obj;
+    PyObject* filename_obj;
+    const char* function_name;
+    const char* filename;
+};
+
+MEMRAY_FAST_TLS thread_local std::array<CodeObjectStrings, 256> t_code_string_cache{};
+
+inline CodeObjectStrings&
+codeStringCacheSlot(PyCodeObject* code)
+{
+    return t_code_string_cache[(reinterpret_cast<uintptr_t>(code) >> 4) & 0xFF];
+}
+
+// The last native stack trace this thread resolved to an index in the native
+// trace tree. Allocation-heavy code tends to unwind to the same stack over
+// and over (e.g. a tight loop calling malloc), and verifying that the fresh
+// unwind matches the previous one is a straight array compare, much cheaper
+// than re-walking the trace tree one frame at a time. Entries are tagged with
+// the tracker generation because the cached index is only meaningful for the
+// tree owned by the tracker that produced it.
+struct NativeTraceCache
+{
+    static constexpr size_t MAX_DEPTH = 64;
+
+    unsigned int tracker_generation;
+    uint32_t size;
+    frame_id_t native_index;
+    NativeTrace::ip_t ips[MAX_DEPTH];
+};
+
+MEMRAY_FAST_TLS thread_local NativeTraceCache t_native_trace_cache{};
+
+// The last line number this thread computed for a frame on its Python stack.
+// PyFrame_GetLineNumber has to decode the code object's line table, and it is
+// asked about the same frame on nearly every allocation. The answer can only
+// change when the frame's instruction offset moves, so remembering which
+// (frame, f_lasti) pair it was computed for makes repeated queries from the
+// same bytecode instruction free. Entries are invalidated when a frame enters
+// the stack mirror, so a frame deallocated and replaced by another one at the
+// same address can't serve a stale line number.
+struct LineNumberCache
+{
+    PyFrameObject* frame;
+    int lasti;
+    int lineno;
+};
+
+MEMRAY_FAST_TLS thread_local LineNumberCache t_lineno_cache{};
+
+int
+frameLineNumber(PyFrameObject* frame)
+{
+    const int lasti = compat::frameGetLasti(frame);
+    if (t_lineno_cache.frame != frame || t_lineno_cache.lasti != lasti) {
+        t_lineno_cache = {frame, lasti, PyFrame_GetLineNumber(frame)};
+    }
+    return t_lineno_cache.lineno;
+}
+
+}  // namespace
+
 static inline thread_id_t
 generate_next_tid()
 {
@@ -86,7 +213,7 @@ class PythonStackTracker
   private:
     PythonStackTracker() = default;
 
-    enum class FrameState {
+    enum class FrameState : uint8_t {
         NOT_EMITTED = 0,
         EMITTED_BUT_LINE_NUMBER_MAY_HAVE_CHANGED = 1,
         EMITTED_AND_LINE_NUMBER_HAS_NOT_CHANGED = 2,
@@ -99,9 +226,62 @@ class PythonStackTracker
         FrameState state;
     };
 
+    // Structure-of-arrays representation of the stack of lazily emitted
+    // frames. The scan in emitPendingPushesAndPops only needs the per-frame
+    // state, so keeping the states densely packed in their own vector avoids
+    // pulling entire frame records into cache just to check a 1 byte field.
+    struct FrameStack
+    {
+        std::vector<PyFrameObject*> frames;
+        std::vector<RawFrame> raw_frame_records;
+        std::vector<FrameState> states;
+
+        bool empty() const
+        {
+            return states.empty();
+        }
+
+        size_t size() const
+        {
+            return states.size();
+        }
+
+        void push_back(const LazilyEmittedFrame& frame)
+        {
+            emplace_back(frame.frame, frame.raw_frame_record, frame.state);
+        }
+
+        void emplace_back(PyFrameObject* frame, const RawFrame& raw_frame_record, FrameState state)
+        {
+            // This may be a new frame object reusing the address of one we
+            // cached a line number for; don't let it inherit that entry.
+            if (t_lineno_cache.frame == frame) {
+                t_lineno_cache.frame = nullptr;
+            }
+            frames.emplace_back(frame);
+            raw_frame_records.emplace_back(raw_frame_record);
+            states.emplace_back(state);
+        }
+
+        void pop_back()
+        {
+            frames.pop_back();
+            raw_frame_records.pop_back();
+            states.pop_back();
+        }
+
+        void clear()
+        {
+            frames.clear();
+            raw_frame_records.clear();
+            states.clear();
+        }
+    };
+
   public:
     static bool s_greenlet_tracking_enabled;
     static bool s_native_tracking_enabled;
+    static std::atomic<unsigned int> s_tracker_generation;
 
     static void installProfileHooks();
     static void removeProfileHooks();
@@ -110,6 +290,13 @@ class PythonStackTracker
 
     static PythonStackTracker& get();
     void emitPendingPushesAndPops();
+
+    // Check whether this thread's mirror of the Python stack is fully
+    // synchronized with what has been written to the output. If it is, return
+    // true and store the tracker generation it is synchronized with;
+    // otherwise the pending pushes or pops must be emitted before any further
+    // thread-specific records are written.
+    static bool stackIsSettled(unsigned int& generation);
     void invalidateMostRecentFrameLineNumber();
     int pushPythonFrame(PyFrameObject* frame);
     void popPythonFrame();
@@ -126,14 +313,14 @@ class PythonStackTracker
     void reloadStackIfTrackerChanged();
 
     void pushLazilyEmittedFrame(const LazilyEmittedFrame& frame);
+    FrameStack& stack();
 
     static std::mutex s_mutex;
     static std::unordered_map<PyThreadState*, std::vector<LazilyEmittedFrame>> s_initial_stack_by_thread;
-    static std::atomic<unsigned int> s_tracker_generation;
 
     uint32_t d_num_pending_pops{};
     uint32_t d_tracker_generation{};
-    std::vector<LazilyEmittedFrame>* d_stack{};
+    FrameStack* d_stack{};
     bool d_greenlet_hooks_installed{};
 };
 
@@ -174,28 +361,36 @@ PythonStackTracker::emitPendingPushesAndPops()
     // 0 or 1 EMITTED_BUT_LINE_NUMBER_MAY_HAVE_CHANGED frame
     // Any number of NOT_EMITTED frames
 
-    auto it = d_stack->rbegin();
-    for (; it != d_stack->rend(); ++it) {
-        if (it->state == FrameState::NOT_EMITTED) {
-            it->raw_frame_record.lineno = PyFrame_GetLineNumber(it->frame);
-        } else if (it->state == FrameState::EMITTED_BUT_LINE_NUMBER_MAY_HAVE_CHANGED) {
-            int lineno = PyFrame_GetLineNumber(it->frame);
-            if (lineno != it->raw_frame_record.lineno) {
-                // Line number was wrong; emit an artificial pop so we can push
-                // back in with the right line number.
-                d_num_pending_pops++;
-                it->state = FrameState::NOT_EMITTED;
-                it->raw_frame_record.lineno = lineno;
-            } else {
-                it->state = FrameState::EMITTED_AND_LINE_NUMBER_HAS_NOT_CHANGED;
-                break;
-            }
+    auto& states = d_stack->states;
+    const size_t size = states.size();
+
+    // Find the most recent frame that has already been emitted. Everything
+    // above it is NOT_EMITTED (== 0, see the invariant above), so this is
+    // just a reverse scan for the last non-zero state byte.
+    ssize_t last_emitted =
+            last_nonzero_byte(reinterpret_cast<const uint8_t*>(states.data()), size);
+
+    size_t first_to_emit = static_cast<size_t>(last_emitted + 1);
+    if (last_emitted >= 0
+        && states[last_emitted] == FrameState::EMITTED_BUT_LINE_NUMBER_MAY_HAVE_CHANGED)
+    {
+        int lineno = frameLineNumber(d_stack->frames[last_emitted]);
+        if (lineno != d_stack->raw_frame_records[last_emitted].lineno) {
+            // Line number was wrong; emit an artificial pop so we can push
+            // back in with the right line number.
+            d_num_pending_pops++;
+            states[last_emitted] = FrameState::NOT_EMITTED;
+            first_to_emit = last_emitted;
         } else {
-            assert(it->state == FrameState::EMITTED_AND_LINE_NUMBER_HAS_NOT_CHANGED);
-            break;
+            states[last_emitted] = FrameState::EMITTED_AND_LINE_NUMBER_HAS_NOT_CHANGED;
         }
     }
-    auto first_to_emit = it.base();
+
+    // Refresh the line numbers of the frames we're about to emit.
+    for (size_t i = first_to_emit; i < size; ++i) {
+        assert(states[i] == FrameState::NOT_EMITTED);
+        d_stack->raw_frame_records[i].lineno = frameLineNumber(d_stack->frames[i]);
+    }
 
     Tracker* tracker = Tracker::getTracker();
     if (tracker) {
@@ -205,12 +400,14 @@ PythonStackTracker::emitPendingPushesAndPops()
             d_num_pending_pops = 0;
         }
 
-        // Emit pending pushes
-        for (auto to_emit = first_to_emit; to_emit != d_stack->end(); ++to_emit) {
-            if (!tracker->pushFrame(to_emit->raw_frame_record)) {
-                break;
-            }
-            to_emit->state = FrameState::EMITTED_AND_LINE_NUMBER_HAS_NOT_CHANGED;
+        // Emit pending pushes, coalescing consecutive pushes into batches
+        if (first_to_emit < size
+            && tracker->pushFrames(&d_stack->raw_frame_records[first_to_emit], size - first_to_emit))
+        {
+            std::fill(
+                    states.begin() + first_to_emit,
+                    states.end(),
+                    FrameState::EMITTED_AND_LINE_NUMBER_HAS_NOT_CHANGED);
         }
     }
 
@@ -224,10 +421,39 @@ PythonStackTracker::invalidateMostRecentFrameLineNumber()
     // recent Python frame can change without us finding out. Cache its line
     // number, but verify it the next time this frame might need to be emitted.
     if (d_stack && !d_stack->empty()
-        && d_stack->back().state == FrameState::EMITTED_AND_LINE_NUMBER_HAS_NOT_CHANGED)
+        && d_stack->states.back() == FrameState::EMITTED_AND_LINE_NUMBER_HAS_NOT_CHANGED)
     {
-        d_stack->back().state = FrameState::EMITTED_BUT_LINE_NUMBER_MAY_HAVE_CHANGED;
+        d_stack->states.back() = FrameState::EMITTED_BUT_LINE_NUMBER_MAY_HAVE_CHANGED;
+    }
+}
+
+bool
+PythonStackTracker::stackIsSettled(unsigned int& generation)
+{
+    PythonStackTracker& tracker = getUnsafe();
+    if (tracker.d_tracker_generation != s_tracker_generation) {
+        // A new tracker was installed; the stack must be reloaded.
+        return false;
+    }
+    generation = tracker.d_tracker_generation;
+    if (tracker.d_num_pending_pops) {
+        return false;
+    }
+    if (!tracker.d_stack || tracker.d_stack->empty()) {
+        return true;
     }
+    switch (tracker.d_stack->states.back()) {
+        case FrameState::NOT_EMITTED:
+            return false;
+        case FrameState::EMITTED_AND_LINE_NUMBER_HAS_NOT_CHANGED:
+            return true;
+        case FrameState::EMITTED_BUT_LINE_NUMBER_MAY_HAVE_CHANGED:
+            // The top frame needs an artificial pop and re-push if its line
+            // number has changed since it was emitted.
+            return frameLineNumber(tracker.d_stack->frames.back())
+                   == tracker.d_stack->raw_frame_records.back().lineno;
+    }
+    return false;
 }
 
 void
@@ -273,32 +499,58 @@ PythonStackTracker::pushPythonFrame(PyFrameObject* frame)
     installGreenletTraceFunctionIfNeeded();
 
     PyCodeObject* code = compat::frameGetCode(frame);
-    const char* function = PyUnicode_AsUTF8(code->co_name);
-    if (function == nullptr) {
-        return -1;
-    }
+    CodeObjectStrings& cached = codeStringCacheSlot(code);
+
+    // Load both string pointers up front so neither the cache validation nor
+    // the second PyUnicode_AsUTF8 call has to wait on the other field's load.
+    PyObject* name_obj = code->co_name;
+    PyObject* filename_obj = code->co_filename;
+
+    const char* function;
+    const char* filename;
+    if (cached.code == code && cached.name_obj == name_obj && cached.filename_obj == filename_obj) {
+        function = cached.function_name;
+        filename = cached.filename;
+    } else {
+        function = PyUnicode_AsUTF8(name_obj);
+        if (function == nullptr) {
+            return -1;
+        }
 
-    const char* filename = PyUnicode_AsUTF8(code->co_filename);
-    if (filename == nullptr) {
-        return -1;
+        filename = PyUnicode_AsUTF8(filename_obj);
+        if (filename == nullptr) {
+            return -1;
+        }
+
+        cached = {code, name_obj, filename_obj, function, filename};
     }
 
     // If native tracking is not enabled, treat every frame as an entry frame.
     // It doesn't matter to the reader, and is more efficient.
     bool is_entry_frame = !s_native_tracking_enabled || compat::isEntryFrame(frame);
-    pushLazilyEmittedFrame({frame, {function, filename, 0, is_entry_frame}, FrameState::NOT_EMITTED});
+    stack().emplace_back(frame, RawFrame{function, filename, 0, is_entry_frame}, FrameState::NOT_EMITTED);
     return 0;
 }
 
 void
 PythonStackTracker::pushLazilyEmittedFrame(const LazilyEmittedFrame& frame)
+{
+    stack().push_back(frame);
+}
+
+PythonStackTracker::FrameStack&
+PythonStackTracker::stack()
 {
     // Note: this function does not require the GIL.
     if (!d_stack) {
-        d_stack = new std::vector<LazilyEmittedFrame>;
-        d_stack->reserve(1024);
+        d_stack = new FrameStack;
+        // Reserve enough room up front that recursive code doesn't hit
+        // reallocations of the stack while we're tracking it.
+        d_stack->frames.reserve(4096);
+        d_stack->raw_frame_records.reserve(4096);
+        d_stack->states.reserve(4096);
     }
-    d_stack->push_back(frame);
+    return *d_stack;
 }
 
 void
@@ -310,7 +562,7 @@ PythonStackTracker::popPythonFrame()
         return;
     }
 
-    if (d_stack->back().state != FrameState::NOT_EMITTED) {
+    if (d_stack->states.back() != FrameState::NOT_EMITTED) {
         d_num_pending_pops += 1;
         assert(d_num_pending_pops != 0);  // Ensure we didn't overflow.
     }
@@ -386,9 +638,10 @@ PythonStackTracker::handleGreenletSwitch(PyObject* from, PyObject* to)
 
     // Clear any old TLS stack, emitting pops for frames that had been pushed.
     if (d_stack) {
-        d_num_pending_pops += std::count_if(d_stack->begin(), d_stack->end(), [](const auto& f) {
-            return f.state != FrameState::NOT_EMITTED;
-        });
+        d_num_pending_pops +=
+                std::count_if(d_stack->states.begin(), d_stack->states.end(), [](FrameState state) {
+                    return state != FrameState::NOT_EMITTED;
+                });
         d_stack->clear();
         emitPendingPushesAndPops();
     }
@@ -427,8 +680,66 @@ PythonStackTracker::handleGreenletSwitch(PyObject* from, PyObject* to)
 
 std::unique_ptr<std::mutex> Tracker::s_mutex(new std::mutex);
 pthread_key_t Tracker::s_native_unwind_vector_key;
+pthread_key_t Tracker::s_allocation_ring_key;
 std::unique_ptr<Tracker> Tracker::s_instance_owner;
-std::atomic<Tracker*> Tracker::s_instance = nullptr;
+alignas(64) std::atomic<Tracker*> Tracker::s_instance = nullptr;
+
+// Lock-free single-producer single-consumer ring buffer holding allocation
+// records that haven't been handed to the writer yet. Each traced thread owns
+// one ring and is its only producer. Records are drained by whichever thread
+// holds Tracker::s_mutex, which serializes all consumers.
+struct AllocationRing
+{
+    // Must be a power of two so that indexes can wrap with a mask.
+    static constexpr size_t CAPACITY = 1024;
+
+    struct Entry
+    {
+        thread_id_t tid;
+        unsigned int tracker_generation;
+        AllocationRecord record;
+    };
+
+    bool tryPush(const Entry& entry)
+    {
+        size_t tail = d_tail.load(std::memory_order_relaxed);
+        size_t head = d_head.load(std::memory_order_acquire);
+        if (tail - head == CAPACITY) {
+            return false;  // Full. The caller must fall back to the locked path.
+        }
+        d_entries[tail & (CAPACITY - 1)] = entry;
+        d_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::atomic<size_t> d_head{0};
+    std::atomic<size_t> d_tail{0};
+    std::array<Entry, CAPACITY> d_entries;
+};
+
+// Every ring ever handed to a thread, plus the rings whose owner thread has
+// died and that a new thread may adopt. Both vectors are guarded by
+// Tracker::s_mutex. The entries themselves are synchronized by the ring's
+// atomic indexes, so a ring on the free list may safely hold undrained
+// records: each entry carries its own thread id and tracker generation.
+static std::vector<AllocationRing*> s_allocation_rings;
+static std::vector<AllocationRing*> s_free_allocation_rings;
+
+static void
+stopTrackingAfterWriteFailure()
+{
+    // Deactivate first, so that in-flight threads stop queueing records for
+    // the failed writer as soon as possible. Report only the first failure:
+    // when the sink has gone bad (e.g. a full disk) every subsequent record
+    // fails to write too, and a synchronously flushed iostream message per
+    // failed record only makes the stampede worse.
+    Tracker::deactivate();
+    static std::atomic_flag reported = ATOMIC_FLAG_INIT;
+    if (!reported.test_and_set()) {
+        constexpr char MSG[] = "memray: Failed to write output, deactivating tracking\n";
+        (void)::write(STDERR_FILENO, MSG, sizeof(MSG) - 1);
+    }
+}
 
 std::vector<PythonStackTracker::LazilyEmittedFrame>
 PythonStackTracker::pythonFrameToStack(PyFrameObject* current_frame)
@@ -529,7 +840,7 @@ PythonStackTracker::clear()
     }
 
     while (!d_stack->empty()) {
-        d_num_pending_pops += (d_stack->back().state != FrameState::NOT_EMITTED);
+        d_num_pending_pops += (d_stack->states.back() != FrameState::NOT_EMITTED);
         d_stack->pop_back();
     }
     emitPendingPushesAndPops();
@@ -549,6 +860,8 @@ Tracker::Tracker(
 , d_follow_fork(follow_fork)
 , d_trace_python_allocators(trace_python_allocators)
 {
+    d_pending_allocations.reserve(PENDING_ALLOCATIONS_MAX);
+
     static std::once_flag once;
     call_once(once, [] {
         // We use the pthread TLS API for this vector because we must be able
@@ -563,6 +876,17 @@ Tracker::Tracker(
             throw std::runtime_error{"Failed to create pthread key"};
         }
 
+        if (0 != pthread_key_create(&s_allocation_ring_key, [](void* data) {
+                // The ring may still hold records; keep it registered so they
+                // get drained, but allow a future thread to adopt it.
+                RecursionGuard guard;
+                std::unique_lock<std::mutex> lock(*s_mutex);
+                s_free_allocation_rings.push_back(static_cast<AllocationRing*>(data));
+            }))
+        {
+            throw std::runtime_error{"Failed to create pthread key"};
+        }
+
         hooks::ensureAllHooksAreValid();
         NativeTrace::setup();
 
@@ -618,6 +942,7 @@ Tracker::~Tracker()
     }
 
     std::scoped_lock<std::mutex> lock(*s_mutex);
+    flushPendingAllocationsUnsafe();
     d_writer->writeTrailer();
     d_writer->writeHeader(true);
     d_writer.reset();
@@ -628,44 +953,115 @@ Tracker::BackgroundThread::BackgroundThread(
         unsigned int memory_interval)
 : d_writer(std::move(record_writer))
 , d_memory_interval(memory_interval)
+, d_pagesize(sysconf(_SC_PAGE_SIZE))
 {
 #ifdef __linux__
-    d_procs_statm.open("/proc/self/statm");
-    if (!d_procs_statm) {
-        throw IoError{"Failed to open /proc/self/statm"};
+    d_procs_statm_fd = ::open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+    if (d_procs_statm_fd < 0) {
+        // Not fatal: getRSS() falls back to getrusage's peak RSS, which can
+        // only move upwards but is better than aborting tracking outright.
+        std::cerr << "WARNING: Failed to open /proc/self/statm; memory records "
+                     "will report peak instead of current RSS"
+                  << std::endl;
     }
+
+    // Memory records are timestamped relative to the realtime epoch, but
+    // CLOCK_MONOTONIC_COARSE is considerably cheaper to sample and immune to
+    // NTP adjustments mid-run. Capture the offset between the two clocks once
+    // so timeElapsed() can use the coarse clock from here on.
+    unsigned long int realtime_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                            std::chrono::system_clock::now().time_since_epoch())
+                                            .count();
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    unsigned long int coarse_ms = ts.tv_sec * 1000UL + ts.tv_nsec / 1000000;
+    d_time_offset = realtime_ms - coarse_ms;
 #endif
 }
 
+Tracker::BackgroundThread::~BackgroundThread()
+{
+    if (d_procs_statm_fd >= 0) {
+        ::close(d_procs_statm_fd);
+    }
+}
+
 unsigned long int
-Tracker::BackgroundThread::timeElapsed()
+Tracker::BackgroundThread::timeElapsed() const
 {
+#ifdef __linux__
+    // 1ms resolution is plenty for samples taken every d_memory_interval ms,
+    // and the coarse clock is ~3x cheaper than CLOCK_REALTIME.
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000 + d_time_offset;
+#else
     std::chrono::milliseconds ms = std::chrono::duration_cast<std::chrono::milliseconds>(
             std::chrono::system_clock::now().time_since_epoch());
     return ms.count();
+#endif
+}
+
+#ifdef __linux__
+static size_t
+getPeakRSSFallback()
+{
+    // ru_maxrss is the process's lifetime peak, not its current residency, so
+    // samples derived from it can never decrease. That makes it unsuitable as
+    // the primary source, but it keeps memory records flowing on systems
+    // where /proc/self/statm can't be read.
+    struct rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
 }
+#endif
 
 size_t
 Tracker::BackgroundThread::getRSS() const
 {
 #ifdef __linux__
-    static long pagesize = sysconf(_SC_PAGE_SIZE);
+    if (d_procs_statm_fd < 0) {
+        return getPeakRSSFallback();
+    }
+
     constexpr int max_unsigned_long_chars = std::numeric_limits<unsigned long>::digits10 + 1;
     constexpr int bufsize = (max_unsigned_long_chars + sizeof(' ')) * 2;
-    char buffer[bufsize];
-    d_procs_statm.read(buffer, sizeof(buffer) - 1);
-    buffer[d_procs_statm.gcount()] = '\0';
-    d_procs_statm.clear();
-    d_procs_statm.seekg(0);
-
-    size_t rss;
-    if (sscanf(buffer, "%*u %zu", &rss) != 1) {
+    char buffer[bufsize + 1];
+    ssize_t nread = ::pread(d_procs_statm_fd, buffer, bufsize, 0);
+    if (nread < 0) {
+        nread = 0;
+    }
+    buffer[nread] = '\0';
+
+    // The first field is the total program size; the resident set size is the
+    // second one. Parse it by hand: this runs on every sample tick, and both
+    // sscanf and the iostream extractors are far more expensive than the read
+    // itself.
+    const char* p = buffer;
+    while (*p && *p != ' ') {
+        ++p;
+    }
+    while (*p == ' ') {
+        ++p;
+    }
+
+    size_t rss = 0;
+    bool parsed = false;
+    while (*p >= '0' && *p <= '9') {
+        rss = rss * 10 + (*p++ - '0');
+        parsed = true;
+    }
+
+    if (!parsed) {
         std::cerr << "WARNING: Failed to read RSS value from /proc/self/statm" << std::endl;
-        d_procs_statm.close();
-        return 0;
+        ::close(d_procs_statm_fd);
+        d_procs_statm_fd = -1;
+        return getPeakRSSFallback();
     }
 
-    return rss * pagesize;
+    return rss * d_pagesize;
 #elif defined(__APPLE__)
     struct mach_task_basic_info info;
     mach_msg_type_number_t infoCount = MACH_TASK_BASIC_INFO_COUNT;
@@ -701,9 +1097,11 @@ Tracker::BackgroundThread::start()
 
             {
                 std::lock_guard<std::mutex> lock(*s_mutex);
+                if (Tracker* tracker = getTracker()) {
+                    tracker->flushPendingAllocationsUnsafe();
+                }
                 if (!d_writer->writeRecord(MemoryRecord{timeElapsed(), rss})) {
-                    std::cerr << "Failed to write output, deactivating tracking" << std::endl;
-                    Tracker::deactivate();
+                    stopTrackingAfterWriteFailure();
                     break;
                 }
             }
@@ -756,6 +1154,12 @@ Tracker::childFork()
     (void)s_mutex.release();
     s_mutex.reset(new std::mutex);
 
+    // Discard any allocation records still sitting in the per-thread rings:
+    // they belong to the parent process's output file.
+    for (AllocationRing* ring : s_allocation_rings) {
+        ring->d_head.store(ring->d_tail.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
     // Save a reference to the old tracker (if any), then unset our singleton.
     Tracker* old_tracker = s_instance;
     Tracker::deactivate();
@@ -826,25 +1230,52 @@ Tracker::trackAllocationImpl(
     PythonStackTracker::get().emitPendingPushesAndPops();
 
     if (d_unwind_native_frames) {
+        // Native allocation records are written directly, so any batched
+        // records must be written first to keep them ordered correctly.
+        flushPendingAllocationsUnsafe();
+
         frame_id_t native_index = 0;
 
         // Skip the internal frames so we don't need to filter them later.
         if (trace && trace.value().size()) {
-            native_index =
-                    d_native_trace_tree.getTraceIndex(trace.value(), [&](frame_id_t ip, uint32_t index) {
-                        return d_writer->writeRecord(UnresolvedNativeFrame{ip, index});
-                    });
+            const NativeTrace& stack = trace.value();
+            const auto depth = static_cast<size_t>(stack.size());
+            const unsigned int generation = PythonStackTracker::s_tracker_generation;
+
+            NativeTraceCache& cache = t_native_trace_cache;
+            bool hit = depth <= NativeTraceCache::MAX_DEPTH && cache.size == depth
+                       && cache.tracker_generation == generation;
+            for (size_t i = 0; hit && i < depth; ++i) {
+                hit = cache.ips[i] == stack[i];
+            }
+
+            if (hit) {
+                native_index = cache.native_index;
+            } else {
+                native_index = d_native_trace_tree.getTraceIndex(
+                        stack,
+                        [&](frame_id_t ip, uint32_t index) {
+                            return d_writer->writeRecord(UnresolvedNativeFrame{ip, index});
+                        });
+                if (depth <= NativeTraceCache::MAX_DEPTH) {
+                    cache.tracker_generation = generation;
+                    cache.size = depth;
+                    cache.native_index = native_index;
+                    for (size_t i = 0; i < depth; ++i) {
+                        cache.ips[i] = stack[i];
+                    }
+                }
+            }
         }
         NativeAllocationRecord record{reinterpret_cast<uintptr_t>(ptr), size, func, native_index};
         if (!d_writer->writeThreadSpecificRecord(thread_id(), record)) {
-            std::cerr << "Failed to write output, deactivating tracking" << std::endl;
-            deactivate();
+            stopTrackingAfterWriteFailure();
         }
     } else {
         AllocationRecord record{reinterpret_cast<uintptr_t>(ptr), size, func};
-        if (!d_writer->writeThreadSpecificRecord(thread_id(), record)) {
-            std::cerr << "Failed to write output, deactivating tracking" << std::endl;
-            deactivate();
+        d_pending_allocations.emplace_back(thread_id(), record);
+        if (d_pending_allocations.size() >= PENDING_ALLOCATIONS_MAX) {
+            flushPendingAllocationsUnsafe();
         }
     }
 }
@@ -853,12 +1284,93 @@ void
 Tracker::trackDeallocationImpl(void* ptr, size_t size, hooks::Allocator func)
 {
     AllocationRecord record{reinterpret_cast<uintptr_t>(ptr), size, func};
-    if (!d_writer->writeThreadSpecificRecord(thread_id(), record)) {
-        std::cerr << "Failed to write output, deactivating tracking" << std::endl;
-        deactivate();
+    if (d_unwind_native_frames) {
+        // Keep deallocations ordered with the directly written allocations.
+        flushPendingAllocationsUnsafe();
+        if (!d_writer->writeThreadSpecificRecord(thread_id(), record)) {
+            stopTrackingAfterWriteFailure();
+        }
+        return;
+    }
+
+    // Allocations sitting in the per-thread rings happened before this
+    // deallocation could have observed the address; pull them into the batch
+    // first so the records stay correctly ordered.
+    drainAllocationRingsUnsafe();
+    d_pending_allocations.emplace_back(thread_id(), record);
+    if (d_pending_allocations.size() >= PENDING_ALLOCATIONS_MAX) {
+        flushPendingAllocationsUnsafe();
+    }
+}
+
+bool
+Tracker::tryEnqueueAllocation(void* ptr, size_t size, hooks::Allocator func)
+{
+    unsigned int generation;
+    if (!PythonStackTracker::stackIsSettled(generation)) {
+        // Pending frame pushes or pops must reach the writer before this
+        // allocation so that it is attributed to the right stack.
+        return false;
+    }
+
+    auto* ring = static_cast<AllocationRing*>(pthread_getspecific(s_allocation_ring_key));
+    if (!ring) {
+        {
+            std::unique_lock<std::mutex> lock(*s_mutex);
+            if (!s_free_allocation_rings.empty()) {
+                ring = s_free_allocation_rings.back();
+                s_free_allocation_rings.pop_back();
+            } else {
+                ring = new AllocationRing;
+                s_allocation_rings.push_back(ring);
+            }
+        }
+        if (pthread_setspecific(s_allocation_ring_key, ring) != 0) {
+            std::cerr << "memray: pthread_setspecific failed" << std::endl;
+            std::unique_lock<std::mutex> lock(*s_mutex);
+            s_free_allocation_rings.push_back(ring);
+            return false;
+        }
+    }
+
+    AllocationRecord record{reinterpret_cast<uintptr_t>(ptr), size, func};
+    return ring->tryPush({thread_id(), generation, record});
+}
+
+void
+Tracker::drainAllocationRingsUnsafe()
+{
+    // Note: caller must hold s_mutex.
+    const unsigned int generation = PythonStackTracker::s_tracker_generation;
+    for (AllocationRing* ring : s_allocation_rings) {
+        size_t head = ring->d_head.load(std::memory_order_relaxed);
+        const size_t tail = ring->d_tail.load(std::memory_order_acquire);
+        for (; head != tail; ++head) {
+            const auto& entry = ring->d_entries[head & (AllocationRing::CAPACITY - 1)];
+            // Discard records enqueued against a previous tracker: they were
+            // meant for an output file that has already been finalized.
+            if (entry.tracker_generation == generation) {
+                d_pending_allocations.emplace_back(entry.tid, entry.record);
+            }
+        }
+        ring->d_head.store(head, std::memory_order_release);
     }
 }
 
+void
+Tracker::flushPendingAllocationsUnsafe()
+{
+    // Note: caller must hold s_mutex.
+    drainAllocationRingsUnsafe();
+    if (d_pending_allocations.empty()) {
+        return;
+    }
+    if (!d_writer->writeAllocationBatch(d_pending_allocations)) {
+        stopTrackingAfterWriteFailure();
+    }
+    d_pending_allocations.clear();
+}
+
 void
 Tracker::invalidate_module_cache_impl()
 {
@@ -872,18 +1384,30 @@ dl_iterate_phdr_callback(struct dl_phdr_info* info, [[maybe_unused]] size_t size
 {
     auto& mappings = *reinterpret_cast<std::vector<ImageSegments>*>(data);
     const char* filename = info->dlpi_name;
-    std::string executable;
     assert(filename != nullptr);
     if (!filename[0]) {
-        executable = get_executable();
-        filename = executable.c_str();
+        filename = get_executable().c_str();
     }
     if (::starts_with(filename, "linux-vdso.so")) {
         // This cannot be resolved to anything, so don't write it to the file
         return 0;
     }
 
-    std::vector<Segment> segments;
+    // Two passes over the program headers: count the PT_LOAD segments first
+    // so the segment vector can be sized exactly, instead of growing (and
+    // reallocating) as we append. This runs once per loaded DSO every time
+    // the module cache is refreshed, so the avoided churn adds up on
+    // processes with many shared libraries.
+    size_t n_segments = 0;
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        if (info->dlpi_phdr[i].p_type == PT_LOAD) {
+            n_segments++;
+        }
+    }
+
+    mappings.push_back({filename, info->dlpi_addr, {}});
+    std::vector<Segment>& segments = mappings.back().segments;
+    segments.reserve(n_segments);
     for (int i = 0; i < info->dlpi_phnum; i++) {
         const auto& phdr = info->dlpi_phdr[i];
         if (phdr.p_type == PT_LOAD) {
@@ -891,7 +1415,6 @@ dl_iterate_phdr_callback(struct dl_phdr_info* info, [[maybe_unused]] size_t size
         }
     }
 
-    mappings.push_back({filename, info->dlpi_addr, std::move(segments)});
     return 0;
 }
 #endif
@@ -903,6 +1426,10 @@ Tracker::updateModuleCacheImpl()
         return;
     }
 
+    // Mapping records are written directly; flush any batched allocations
+    // first so that the record order in the output is preserved.
+    flushPendingAllocationsUnsafe();
+
     static size_t s_last_mappings_size = 20;
 
     std::vector<ImageSegments> mappings;
@@ -934,8 +1461,7 @@ Tracker::updateModuleCacheImpl()
     s_last_mappings_size = mappings.size();
 
     if (!d_writer->writeMappings(mappings)) {
-        std::cerr << "memray: Failed to write output, deactivating tracking" << std::endl;
-        Tracker::deactivate();
+        stopTrackingAfterWriteFailure();
         return;
     }
 }
@@ -944,9 +1470,9 @@ void
 Tracker::registerThreadNameImpl(const char* name)
 {
     RecursionGuard guard;
+    flushPendingAllocationsUnsafe();
     if (!d_writer->writeThreadSpecificRecord(thread_id(), ThreadRecord{name})) {
-        std::cerr << "memray: Failed to write output, deactivating tracking" << std::endl;
-        deactivate();
+        stopTrackingAfterWriteFailure();
     }
 }
 
@@ -957,8 +1483,7 @@ Tracker::registerFrame(const RawFrame& frame)
     if (is_new_frame) {
         pyrawframe_map_val_t frame_index{frame_id, frame};
         if (!d_writer->writeRecord(frame_index)) {
-            std::cerr << "memray: Failed to write output, deactivating tracking" << std::endl;
-            deactivate();
+            stopTrackingAfterWriteFailure();
         }
     }
     return frame_id;
@@ -967,24 +1492,34 @@ Tracker::registerFrame(const RawFrame& frame)
 bool
 Tracker::popFrames(uint32_t count)
 {
+    flushPendingAllocationsUnsafe();
     const FramePop entry{count};
     if (!d_writer->writeThreadSpecificRecord(thread_id(), entry)) {
-        std::cerr << "memray: Failed to write output, deactivating tracking" << std::endl;
-        deactivate();
+        stopTrackingAfterWriteFailure();
         return false;
     }
     return true;
 }
 
 bool
-Tracker::pushFrame(const RawFrame& frame)
+Tracker::pushFrames(const RawFrame* frames, size_t count)
 {
-    const frame_id_t frame_id = registerFrame(frame);
-    const FramePush entry{frame_id};
-    if (!d_writer->writeThreadSpecificRecord(thread_id(), entry)) {
-        std::cerr << "memray: Failed to write output, deactivating tracking" << std::endl;
-        deactivate();
-        return false;
+    flushPendingAllocationsUnsafe();
+    while (count) {
+        // New frames are still registered (and FRAME_INDEX records written)
+        // one at a time, but the pushes themselves go out in one record.
+        std::array<frame_id_t, 64> frame_ids;
+        const size_t batch_size = std::min(count, frame_ids.size());
+        for (size_t i = 0; i < batch_size; ++i) {
+            frame_ids[i] = registerFrame(frames[i]);
+        }
+        const FramePushBatch entry{frame_ids.data(), batch_size};
+        if (!d_writer->writeThreadSpecificRecord(thread_id(), entry)) {
+            stopTrackingAfterWriteFailure();
+            return false;
+        }
+        frames += batch_size;
+        count -= batch_size;
     }
     return true;
 }
@@ -1002,12 +1537,6 @@ Tracker::deactivate()
     s_instance = nullptr;
 }
 
-bool
-Tracker::isActive()
-{
-    return s_instance != nullptr;
-}
-
 // Static methods managing the singleton
 
 PyObject*
@@ -1093,13 +1622,25 @@ Tracker::unregisterPymallocHooks() const noexcept
 PyObject*
 create_profile_arg()
 {
-    // Borrowed reference
-    PyObject* memray_ext = PyDict_GetItemString(PyImport_GetModuleDict(), "memray._memray");
-    if (!memray_ext) {
-        return nullptr;
+    // Each thread needs its own ProfileFunctionGuard instance, but the class
+    // can be resolved once and reused, skipping the module dict and attribute
+    // lookups on every thread creation. The reference is intentionally held
+    // for the life of the process. Synchronized by the GIL.
+    static PyObject* guard_type = nullptr;
+    if (!guard_type) {
+        // Borrowed reference
+        PyObject* memray_ext = PyDict_GetItemString(PyImport_GetModuleDict(), "memray._memray");
+        if (!memray_ext) {
+            return nullptr;
+        }
+
+        guard_type = PyObject_GetAttrString(memray_ext, "ProfileFunctionGuard");
+        if (!guard_type) {
+            return nullptr;
+        }
     }
 
-    return PyObject_CallMethod(memray_ext, "ProfileFunctionGuard", nullptr);
+    return PyObject_CallObject(guard_type, nullptr);
 }
 
 // Called when profiling is initially enabled in each thread.
@@ -1126,6 +1667,12 @@ PyTraceFunction(
         int what,
         [[maybe_unused]] PyObject* arg)
 {
+    // Touch the frame early: both the stack mirror operations below and the
+    // code object lookup in pushPythonFrame start with dependent loads
+    // through this pointer, and the prefetch costs nearly nothing even when
+    // tracking turns out to be inactive.
+    __builtin_prefetch(frame, 0, 3);
+
     RecursionGuard guard;
     if (!Tracker::isActive()) {
         return 0;
@@ -6,7 +6,6 @@
 #include <atomic>
 #include <condition_variable>
 #include <cstddef>
-#include <fstream>
 #include <iterator>
 #include <memory>
 #include <optional>
@@ -208,7 +207,7 @@ class Tracker
     __attribute__((always_inline)) inline static void
     trackAllocation(void* ptr, size_t size, hooks::Allocator func)
     {
-        if (RecursionGuard::isActive || !Tracker::isActive()) {
+        if (__builtin_expect(RecursionGuard::isActive || !Tracker::isActive(), 0)) {
             return;
         }
         RecursionGuard guard;
@@ -220,6 +219,11 @@ class Tracker
             }
             // Skip the internal frames so we don't need to filter them later.
             trace.value().fill(1);
+        } else if (tryEnqueueAllocation(ptr, size, func)) {
+            // Common case: the record was stashed in this thread's ring
+            // buffer without taking s_mutex. It will be handed to the writer
+            // in bulk by whichever thread next writes any other record.
+            return;
         }
 
         std::unique_lock<std::mutex> lock(*s_mutex);
@@ -250,7 +254,12 @@ class Tracker
     __attribute__((always_inline)) inline static void
     trackDeallocation(void* ptr, size_t size, hooks::Allocator func)
     {
-        if (RecursionGuard::isActive || !Tracker::isActive()) {
+        // free(NULL) is a valid no-op that programs hit surprisingly often;
+        // don't pay for a record (or the lock) to report nothing was freed.
+        if (__builtin_expect(ptr == nullptr, 0)) {
+            return;
+        }
+        if (__builtin_expect(RecursionGuard::isActive || !Tracker::isActive(), 0)) {
             return;
         }
         RecursionGuard guard;
@@ -291,11 +300,18 @@ class Tracker
     }
 
     // RawFrame stack interface
-    bool pushFrame(const RawFrame& frame);
+    bool pushFrames(const RawFrame* frames, size_t count);
     bool popFrames(uint32_t count);
 
     // Interface to activate/deactivate the tracking
-    static bool isActive();
+    __attribute__((always_inline)) inline static bool isActive()
+    {
+        // This is only a hint: every path that acts on the tracker re-fetches
+        // it with getTracker() while holding s_mutex, so a relaxed load is
+        // enough here and avoids imposing acquire ordering on every single
+        // allocation performed by the traced process.
+        return s_instance.load(std::memory_order_relaxed) != nullptr;
+    }
     static void activate();
     static void deactivate();
 
@@ -323,6 +339,7 @@ class Tracker
       public:
         // Constructors
         BackgroundThread(std::shared_ptr<RecordWriter> record_writer, unsigned int memory_interval);
+        ~BackgroundThread();
 
         // Methods
         void start();
@@ -336,21 +353,35 @@ class Tracker
         std::mutex d_mutex;
         std::condition_variable d_cv;
         std::thread d_thread;
-        mutable std::ifstream d_procs_statm;
+        mutable int d_procs_statm_fd{-1};
+        const long d_pagesize;
+        unsigned long int d_time_offset{0};
 
         // Methods
         size_t getRSS() const;
-        static unsigned long int timeElapsed();
+        unsigned long int timeElapsed() const;
     };
 
     // Data members
     static std::unique_ptr<std::mutex> s_mutex;
     static pthread_key_t s_native_unwind_vector_key;
+    static pthread_key_t s_allocation_ring_key;
     static std::unique_ptr<Tracker> s_instance_owner;
-    static std::atomic<Tracker*> s_instance;
+
+    // Read by every traced allocation and written on activation and
+    // deactivation. Give it a cache line of its own so those writes don't
+    // invalidate lines holding the neighbouring statics (and vice versa).
+    alignas(64) static std::atomic<Tracker*> s_instance;
+
+    // How many allocation records to accumulate before handing them to the
+    // writer in one batch. The batch is flushed early whenever any other
+    // record type is written, so readers observe the exact same record order
+    // as if each allocation had been written immediately.
+    static constexpr size_t PENDING_ALLOCATIONS_MAX = 256;
 
     FrameCollection<RawFrame> d_frames;
     std::shared_ptr<RecordWriter> d_writer;
+    RecordWriter::AllocationBatch d_pending_allocations;
     FrameTree d_native_trace_tree;
     const bool d_unwind_native_frames;
     const unsigned int d_memory_interval;
@@ -362,6 +393,9 @@ class Tracker
     // Methods
     static size_t computeMainTidSkip();
     frame_id_t registerFrame(const RawFrame& frame);
+    static bool tryEnqueueAllocation(void* ptr, size_t size, hooks::Allocator func);
+    void drainAllocationRingsUnsafe();
+    void flushPendingAllocationsUnsafe();
 
     void trackAllocationImpl(
             void* ptr,